@@ -1,8 +1,14 @@
 #include "particles.h"
 
 
-int main()
+int main( int argc, char** argv )
 {
+    if ( argc > 1 && std::string_view( argv[1] ) == "--benchmark-integrators" )
+    {
+        benchmark_integrators();
+        return 0;
+    }
+
     Particles particles{};
     while ( particles.process() );
     return 0;
@@ -28,6 +28,13 @@ Particles::Particles()
 
     reload_container_mesh();
 
+    kl::dx::SamplerStateDescriptor sampler_descriptor{};
+    sampler_descriptor.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    sampler_descriptor.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampler_descriptor.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampler_descriptor.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    field_sampler = gpu.create_sampler_state( &sampler_descriptor );
+
     camera.speed = 5.0f;       // camera distance
     camera.sensitivity = 0.5f; // deg/px
     camera.background = kl::RGB{ 40, 40, 40 };
@@ -213,29 +220,18 @@ void Particles::update_camera()
 
 void Particles::compute_physics()
 {
-    struct alignas( 16 ) CB
-    {
-        kl::Float3 FORCE_RAY_ORIGIN;
-        float USE_RAY_FORCE;
-        kl::Float3 FORCE_RAY_DIRECTION;
-        float FORCE_STRENGTH;
-        kl::Float3 CONTAINER_SCALE;
-        float RETURN_HOME;
-        float RETURN_HOME_VELOCITY;
-        float ENERGY_RETAIN;
-        float ELAPSED_TIME;
-        float DELTA_TIME;
-        UINT PARTICLE_COUNT;
-    } cb = {};
+    PhysicsCB cb = {};
 
-    cb.PARTICLE_COUNT = gpu.vertex_buffer_size( particle_buffer, sizeof( Particle ) );
     cb.ELAPSED_TIME = timer.elapsed();
-    cb.DELTA_TIME = timer.delta();
     cb.RETURN_HOME = (float) return_home;
     cb.RETURN_HOME_VELOCITY = return_home_velocity;
     cb.CONTAINER_SCALE = container_scale;
     cb.FORCE_STRENGTH = force_strength;
     cb.ENERGY_RETAIN = energy_retain;
+    cb.INTEGRATION_TYPE = (UINT) integration_type;
+    cb.MAX_SUBSTEPS = (UINT) kl::clamp( max_substeps, 1, SUBSTEP_LIMIT );
+    cb.USE_FIELD = float( use_field && field.resolution > 0 );
+    cb.FIELD_STRENGTH = field_strength;
 
     if ( window.mouse.left && !is_ui_hovered )
     {
@@ -246,12 +242,69 @@ void Particles::compute_physics()
         cb.USE_RAY_FORCE = 1.0f;
     }
 
+    // Fixed steps decouple the simulated step size from the frame rate
+    const float simulated_time = timer.delta() * simulation_speed;
+    int step_count = 1;
+    if ( use_fixed_time_step )
+    {
+        cb.DELTA_TIME = kl::max( fixed_time_step, 1e-4f );
+        time_step_accumulator += simulated_time;
+        step_count = kl::min( int( time_step_accumulator / cb.DELTA_TIME ), STEPS_PER_FRAME_LIMIT );
+        time_step_accumulator = kl::min( time_step_accumulator - step_count * cb.DELTA_TIME, cb.DELTA_TIME );
+    }
+    else
+    {
+        cb.DELTA_TIME = simulated_time;
+    }
+
+    for ( int i = 0; i < step_count; i++ )
+    {
+        if ( use_cpu_physics )
+            compute_physics_cpu( cb );
+        else
+            compute_physics_gpu( cb );
+    }
+
+    if ( use_cpu_physics && step_count > 0 )
+        upload_particle_buffers();
+}
+
+void Particles::compute_physics_gpu( PhysicsCB const& cb )
+{
     gpu.bind_compute_shader( compute_shader.shader );
-    compute_shader.upload( cb );
+    gpu.bind_shader_view_for_compute_shader( field_view, 0 );
+    gpu.bind_sampler_state_for_compute_shader( field_sampler, 0 );
+
+    for ( size_t i = 0; i < particle_buffers.size(); i++ )
+    {
+        PhysicsCB chunk_cb = cb;
+        chunk_cb.PARTICLE_COUNT = gpu.vertex_buffer_size( particle_buffers[i], sizeof( Particle ) );
+        compute_shader.upload( chunk_cb );
+
+        gpu.bind_access_view_for_compute_shader( particle_buffer_views[i], 0 );
+        gpu.dispatch_compute_shader( chunk_cb.PARTICLE_COUNT / 1024 + 1, 1, 1 );
+        gpu.unbind_access_view_for_compute_shader( 0 );
+    }
+
+    gpu.unbind_shader_view_for_compute_shader( 0 );
+}
+
+void Particles::compute_physics_cpu( PhysicsCB const& cb )
+{
+    if ( particles.empty() )
+        return;
+
+    std::for_each( std::execution::par_unseq, particles.begin(), particles.end(), [&]( Particle& particle )
+        {
+            step_particle( particle, cb, field );
+        } );
+}
 
-    gpu.bind_access_view_for_compute_shader( particle_buffer_view, 0 );
-    gpu.dispatch_compute_shader( cb.PARTICLE_COUNT / 1024 + 1, 1, 1 );
-    gpu.unbind_access_view_for_compute_shader( 0 );
+void Particles::upload_particle_buffers()
+{
+    // Rendering always reads the particle buffers, so the whole state is uploaded every frame
+    for ( size_t i = 0; i < particle_buffers.size(); i++ )
+        gpu.context()->UpdateSubresource( particle_buffers[i].get(), 0, nullptr, particles.data() + i * PARTICLE_CHUNK_SIZE, 0, 0 );
 }
 
 void Particles::render_particles()
@@ -266,7 +319,8 @@ void Particles::render_particles()
     gpu.bind_shaders( shaders );
     shaders.upload( cb );
 
-    gpu.draw( particle_buffer, D3D_PRIMITIVE_TOPOLOGY_POINTLIST, sizeof( Particle ) );
+    for ( kl::dx::Buffer const& particle_buffer : particle_buffers )
+        gpu.draw( particle_buffer, D3D_PRIMITIVE_TOPOLOGY_POINTLIST, sizeof( Particle ) );
     gpu.draw( container_mesh, D3D_PRIMITIVE_TOPOLOGY_LINELIST, sizeof( Particle ) );
 }
 
@@ -297,13 +351,79 @@ void Particles::render_ui()
         drag_float( "Energy Retain", energy_retain, [] {} );
         drag_float( "Return Home Velocity", return_home_velocity, [] {} );
         imgui::Checkbox( "Return Home", &return_home );
+        if ( imgui::Checkbox( "Use CPU Physics", &use_cpu_physics ) && use_cpu_physics )
+            use_cpu_physics = read_particle_buffers();
+        bool integration_type_check = integration_type == IntegrationType::SEMI_IMPLICIT_EULER;
+        if ( imgui::Checkbox( "Semi-Implicit Euler##IntegrationType", &integration_type_check ) )
+            integration_type = IntegrationType::SEMI_IMPLICIT_EULER;
+        imgui::SameLine();
+        integration_type_check = integration_type == IntegrationType::VELOCITY_VERLET;
+        if ( imgui::Checkbox( "Velocity Verlet##IntegrationType", &integration_type_check ) )
+            integration_type = IntegrationType::VELOCITY_VERLET;
+        imgui::SameLine();
+        integration_type_check = integration_type == IntegrationType::ADAPTIVE_VERLET;
+        if ( imgui::Checkbox( "Adaptive Verlet##IntegrationType", &integration_type_check ) )
+            integration_type = IntegrationType::ADAPTIVE_VERLET;
+        if ( integration_type == IntegrationType::ADAPTIVE_VERLET )
+            drag_int( "Max Substeps", max_substeps, [this] { max_substeps = kl::clamp( max_substeps, 1, SUBSTEP_LIMIT ); } );
+        drag_float( "Simulation Speed", simulation_speed, [this] { simulation_speed = kl::max( simulation_speed, 0.0f ); } );
+        imgui::Checkbox( "Fixed Time Step", &use_fixed_time_step );
+        if ( use_fixed_time_step )
+            drag_float( "Time Step", fixed_time_step, [this] { fixed_time_step = kl::max( fixed_time_step, 1e-4f ); }, 100.0f, 1e-4f );
+
+        imgui::Separator();
+
+        const size_t field_texel_count = field.texels.size();
+        imgui::Text( kl::format( "Field Resolution: ", field.resolution, " [", field_texel_count * sizeof( DirectX::PackedVector::XMHALF4 ) * 1e-6, " MB]" ).c_str() );
+        imgui::Checkbox( "Use Field", &use_field );
+        drag_float( "Field Strength", field_strength, [] {} );
+        bool field_type_check = field_type == FieldType::VORTEX;
+        if ( imgui::Checkbox( "Vortex##FieldType", &field_type_check ) )
+            field_type = FieldType::VORTEX;
+        imgui::SameLine();
+        field_type_check = field_type == FieldType::ATTRACTOR;
+        if ( imgui::Checkbox( "Attractor##FieldType", &field_type_check ) )
+            field_type = FieldType::ATTRACTOR;
+        imgui::SameLine();
+        field_type_check = field_type == FieldType::CURL_NOISE;
+        if ( imgui::Checkbox( "Curl Noise##FieldType", &field_type_check ) )
+            field_type = FieldType::CURL_NOISE;
+        drag_int( "Field Resolution", field_resolution, [this] { field_resolution = kl::clamp( field_resolution, 2, FIELD_RESOLUTION_LIMIT ); } );
+        if ( field_type == FieldType::CURL_NOISE )
+            drag_float( "Field Frequency", field_frequency, [] {} );
+        if ( imgui::Button( "Bake Field" ) )
+        {
+            bake_field();
+            reload_field_view();
+        }
+        imgui::SameLine();
+        if ( imgui::Button( "Load Field" ) )
+        {
+            if ( auto opt_file = kl::choose_file( false, { { "Field Files", ".field" } } ) )
+            {
+                field_path = *opt_file;
+                if ( load_field() )
+                    reload_field_view();
+            }
+        }
+        imgui::SameLine();
+        imgui::BeginDisabled( field.resolution <= 0 );
+        if ( imgui::Button( "Save Field" ) )
+        {
+            if ( auto opt_file = kl::choose_file( true, { { "Field Files", ".field" } } ) )
+            {
+                if ( save_field( *opt_file ) )
+                    field_path = *opt_file;
+            }
+        }
+        imgui::EndDisabled();
 
         imgui::Separator();
 
         const size_t cpu_size = particles.size();
-        const UINT gpu_size = gpu.vertex_buffer_size( particle_buffer, sizeof( Particle ) );
+        const size_t gpu_size = gpu_particle_count();
         imgui::Text( kl::format( "CPU Particle Count: ", cpu_size, " [", cpu_size * sizeof( Particle ) * 1e-6, " MB]" ).c_str() );
-        imgui::Text( kl::format( "GPU Particle Count: ", gpu_size, " [", gpu_size * sizeof( Particle ) * 1e-6, " MB]" ).c_str() );
+        imgui::Text( kl::format( "GPU Particle Count: ", gpu_size, " [", gpu_size * sizeof( Particle ) * 1e-6, " MB, ", particle_buffers.size(), " chunks]" ).c_str() );
         drag_int( "Box Particle Count", box_particle_count, [] {} );
         drag_float( "Box Particle Velocity Limit", box_particle_velocity_limit, [] {} );
         bool box_color_type = box_particle_color_type == ColorType::SINGLE;
@@ -326,15 +446,18 @@ void Particles::render_ui()
         if ( imgui::Button( "Generate Box Particles" ) )
         {
             generate_particle_box();
-            reload_particle_buffer();
+            reload_particle_buffers();
         }
 
         imgui::Separator();
 
         const size_t triangle_count = selected_mesh_triangles.size();
         imgui::Text( kl::format( "Mesh Triangle Count: ", triangle_count, " [", triangle_count * sizeof( kl::Triangle ) * 1e-6, " MB]" ).c_str() );
-        const size_t image_size = (size_t) selected_texture.width() * selected_texture.height();
-        imgui::Text( kl::format( "Texture Resolution: ", selected_texture.size(), " [", image_size * sizeof( kl::RGB ) * 1e-6, " MB]" ).c_str() );
+        const kl::Int2 texture_size = selected_texture_mips.empty() ? kl::Int2{} : selected_texture_mips.front().image.size();
+        size_t texture_pixel_count = 0;
+        for ( TextureMip const& mip : selected_texture_mips )
+            texture_pixel_count += (size_t) mip.image.width() * mip.image.height();
+        imgui::Text( kl::format( "Texture Resolution: ", texture_size, " [", texture_pixel_count * sizeof( kl::RGB ) * 1e-6, " MB, ", selected_texture_mips.size(), " mips]" ).c_str() );
         if ( !selected_mesh_path.empty() )
         {
             if ( imgui::Button( "Erase##SelectedMeshPath" ) )
@@ -373,7 +496,7 @@ void Particles::render_ui()
             if ( use_texture )
                 reload_selected_texture();
             generate_particle_mesh();
-            reload_particle_buffer();
+            reload_particle_buffers();
         }
         imgui::EndDisabled();
     }
@@ -398,24 +521,114 @@ void Particles::reload_selected_mesh()
 
 void Particles::reload_selected_texture()
 {
-    selected_texture = {};
-    selected_texture.load_from_file( selected_texture_path );
+    selected_texture_mips.clear();
+
+    kl::Image image;
+    image.load_from_file( selected_texture_path );
+    if ( image.width() <= 0 || image.height() <= 0 )
+        return;
+
+    // Decoded image becomes the base level as is, no second full resolution copy
+    selected_texture_mips.emplace_back().image = std::move( image );
+
+    // Every level box filters the previous one, so coarse particle grids don't alias
+    while ( selected_texture_mips.back().image.width() > 1 || selected_texture_mips.back().image.height() > 1 )
+    {
+        const TextureMip& source = selected_texture_mips.back();
+        const int source_width = source.image.width();
+        const int source_height = source.image.height();
+        const int width = kl::max( source_width / 2, 1 );
+        const int height = kl::max( source_height / 2, 1 );
+
+        TextureMip mip;
+        mip.image = kl::Image{ kl::Int2{ width, height } };
+
+        kl::RGB* pixels = mip.image.ptr();
+        std::for_each( std::execution::par, pixels, pixels + (size_t) width * height, [&]( kl::RGB& pixel )
+            {
+                const int index = int( &pixel - pixels );
+                const int x = index % width;
+                const int y = index / width;
+
+                // Last row and column also take the leftover texel of odd sized sources
+                const int start_x = x * 2;
+                const int start_y = y * 2;
+                const int end_x = x == width - 1 ? source_width - 1 : start_x + 1;
+                const int end_y = y == height - 1 ? source_height - 1 : start_y + 1;
+
+                kl::Float3 sum;
+                for ( int source_y = start_y; source_y <= end_y; source_y++ )
+                {
+                    for ( int source_x = start_x; source_x <= end_x; source_x++ )
+                        sum += source.pixel( source_x, source_y );
+                }
+                pixel = sum / float( ( end_x - start_x + 1 ) * ( end_y - start_y + 1 ) );
+            } );
+        selected_texture_mips.push_back( std::move( mip ) );
+    }
+}
+
+void Particles::reload_particle_buffers()
+{
+    particle_buffers.clear();
+    particle_buffer_views.clear();
+
+    for ( size_t offset = 0; offset < particles.size(); offset += PARTICLE_CHUNK_SIZE )
+    {
+        const size_t chunk_size = kl::min( PARTICLE_CHUNK_SIZE, particles.size() - offset );
+
+        kl::dx::BufferDescriptor descriptor{};
+        descriptor.Usage = D3D11_USAGE_DEFAULT;
+        descriptor.StructureByteStride = sizeof( Particle );
+        descriptor.ByteWidth = UINT( chunk_size * sizeof( Particle ) );
+        descriptor.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+        descriptor.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+
+        kl::dx::SubresourceDescriptor subresource_data{};
+        subresource_data.pSysMem = particles.data() + offset;
+
+        kl::dx::Buffer& particle_buffer = particle_buffers.emplace_back( gpu.create_buffer( &descriptor, &subresource_data ) );
+        particle_buffer_views.push_back( gpu.create_access_view( particle_buffer, nullptr ) );
+    }
 }
 
-void Particles::reload_particle_buffer()
+bool Particles::read_particle_buffers()
 {
-    kl::dx::BufferDescriptor descriptor{};
-    descriptor.Usage = D3D11_USAGE_DEFAULT;
-    descriptor.StructureByteStride = sizeof( Particle );
-    descriptor.ByteWidth = UINT( particles.size() * sizeof( Particle ) );
-    descriptor.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-    descriptor.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    std::vector<Particle> gpu_particles( gpu_particle_count() );
+    size_t offset = 0;
 
-    kl::dx::SubresourceDescriptor subresource_data{};
-    subresource_data.pSysMem = particles.data();
+    for ( kl::dx::Buffer const& particle_buffer : particle_buffers )
+    {
+        const size_t chunk_size = gpu.vertex_buffer_size( particle_buffer, sizeof( Particle ) );
+
+        kl::dx::BufferDescriptor descriptor{};
+        descriptor.Usage = D3D11_USAGE_STAGING;
+        descriptor.ByteWidth = UINT( chunk_size * sizeof( Particle ) );
+        descriptor.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+        const kl::dx::Buffer staging_buffer = gpu.create_buffer( &descriptor, nullptr );
+        if ( !staging_buffer )
+            return false;
+        gpu.context()->CopyResource( staging_buffer.get(), particle_buffer.get() );
+
+        D3D11_MAPPED_SUBRESOURCE mapped_subresource{};
+        if ( FAILED( gpu.context()->Map( staging_buffer.get(), 0, D3D11_MAP_READ, 0, &mapped_subresource ) ) )
+            return false;
+        memcpy( gpu_particles.data() + offset, mapped_subresource.pData, chunk_size * sizeof( Particle ) );
+        gpu.context()->Unmap( staging_buffer.get(), 0 );
+        offset += chunk_size;
+    }
+
+    particles = std::move( gpu_particles );
+    return true;
+}
 
-    particle_buffer = gpu.create_buffer( &descriptor, &subresource_data );
-    particle_buffer_view = gpu.create_access_view( particle_buffer, nullptr );
+size_t Particles::gpu_particle_count()
+{
+    size_t count = 0;
+    for ( kl::dx::Buffer const& particle_buffer : particle_buffers )
+        count += gpu.vertex_buffer_size( particle_buffer, sizeof( Particle ) );
+    return count;
 }
 
 void Particles::reload_container_mesh()
@@ -442,6 +655,113 @@ void Particles::reload_container_mesh()
     container_mesh = gpu.create_buffer( &descriptor, &subresource_data );
 }
 
+void Particles::reload_field_view()
+{
+    field_view = {};
+    if ( field.resolution <= 0 )
+        return;
+
+    D3D11_TEXTURE3D_DESC descriptor{};
+    descriptor.Width = UINT( field.resolution );
+    descriptor.Height = UINT( field.resolution );
+    descriptor.Depth = UINT( field.resolution );
+    descriptor.MipLevels = 1;
+    descriptor.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    descriptor.Usage = D3D11_USAGE_IMMUTABLE;
+    descriptor.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    kl::dx::SubresourceDescriptor subresource_data{};
+    subresource_data.pSysMem = field.texels.data();
+    subresource_data.SysMemPitch = UINT( field.resolution * sizeof( DirectX::PackedVector::XMHALF4 ) );
+    subresource_data.SysMemSlicePitch = subresource_data.SysMemPitch * field.resolution;
+
+    // CPU and GPU have to see the same field, so a failed upload drops it on both sides
+    kl::ComRef<ID3D11Texture3D> texture;
+    if ( FAILED( gpu.device()->CreateTexture3D( &descriptor, &subresource_data, &texture ) )
+        || FAILED( gpu.device()->CreateShaderResourceView( texture.get(), nullptr, &field_view ) ) )
+    {
+        field = {};
+        field_view = {};
+    }
+}
+
+static kl::Float3 field_value( FieldType type, kl::Float3 const& position, float frequency )
+{
+    switch ( type )
+    {
+    default:
+        return {};
+
+    case FieldType::VORTEX:
+        return kl::Float3{ -position.z, 0.0f, position.x } - position * 0.25f;
+
+    case FieldType::ATTRACTOR:
+        return -position;
+
+    case FieldType::CURL_NOISE:
+    {
+        static constexpr float EPSILON = 1e-3f;
+        const auto potential = [&]( kl::Float3 const& p )
+            {
+                return kl::Float3{
+                    std::sin( frequency * p.y + 1.3f ) * std::cos( frequency * p.z + 2.1f ),
+                    std::sin( frequency * p.z + 3.7f ) * std::cos( frequency * p.x + 0.4f ),
+                    std::sin( frequency * p.x + 5.2f ) * std::cos( frequency * p.y + 4.6f ),
+                };
+            };
+        const kl::Float3 dx = ( potential( position + kl::Float3{ EPSILON, 0.0f, 0.0f } ) - potential( position - kl::Float3{ EPSILON, 0.0f, 0.0f } ) ) / ( 2 * EPSILON );
+        const kl::Float3 dy = ( potential( position + kl::Float3{ 0.0f, EPSILON, 0.0f } ) - potential( position - kl::Float3{ 0.0f, EPSILON, 0.0f } ) ) / ( 2 * EPSILON );
+        const kl::Float3 dz = ( potential( position + kl::Float3{ 0.0f, 0.0f, EPSILON } ) - potential( position - kl::Float3{ 0.0f, 0.0f, EPSILON } ) ) / ( 2 * EPSILON );
+        return { dy.z - dz.y, dz.x - dx.z, dx.y - dy.x };
+    }
+    }
+}
+
+void Particles::bake_field()
+{
+    field.resolution = kl::clamp( field_resolution, 2, FIELD_RESOLUTION_LIMIT );
+    field.texels.resize( (size_t) field.resolution * field.resolution * field.resolution );
+
+    // Field spans the container in [-1, 1] on every axis, texel centers included
+    const int resolution = field.resolution;
+    std::for_each( std::execution::par, field.texels.begin(), field.texels.end(), [&]( DirectX::PackedVector::XMHALF4& texel )
+        {
+            const size_t index = &texel - field.texels.data();
+            const kl::Float3 texel_position{
+                ( index % resolution + 0.5f ) / resolution * 2.0f - 1.0f,
+                ( index / resolution % resolution + 0.5f ) / resolution * 2.0f - 1.0f,
+                ( index / ( resolution * resolution ) + 0.5f ) / resolution * 2.0f - 1.0f,
+            };
+            const kl::Float3 value = field_value( field_type, texel_position, field_frequency );
+            texel = DirectX::PackedVector::XMHALF4{ value.x, value.y, value.z, 0.0f };
+        } );
+}
+
+bool Particles::load_field()
+{
+    std::ifstream file( field_path, std::ios::binary );
+    int resolution = 0;
+    if ( !file.read( (char*) &resolution, sizeof( resolution ) ) || resolution < 2 || resolution > FIELD_RESOLUTION_LIMIT )
+        return false;
+
+    std::vector<DirectX::PackedVector::XMHALF4> texels( (size_t) resolution * resolution * resolution );
+    if ( !file.read( (char*) texels.data(), texels.size() * sizeof( DirectX::PackedVector::XMHALF4 ) ) )
+        return false;
+
+    field.resolution = resolution;
+    field.texels = std::move( texels );
+    return true;
+}
+
+bool Particles::save_field( std::string const& path ) const
+{
+    std::ofstream file( path, std::ios::binary );
+    file.write( (const char*) &field.resolution, sizeof( field.resolution ) );
+    file.write( (const char*) field.texels.data(), field.texels.size() * sizeof( DirectX::PackedVector::XMHALF4 ) );
+    file.flush();
+    return bool( file );
+}
+
 void Particles::generate_particle_box()
 {
     particles.resize( box_particle_count );
@@ -460,14 +780,16 @@ void Particles::generate_particle_mesh()
 {
     particles.clear();
     particles.reserve( 1'000'000 );
+    std::vector<TextureLookup> texture_lookups;
 
     if ( use_wireframe )
     {
         for ( kl::Triangle const& triangle : selected_mesh_triangles )
         {
-            generate_particle_line( triangle, triangle.a.position, triangle.b.position );
-            generate_particle_line( triangle, triangle.b.position, triangle.c.position );
-            generate_particle_line( triangle, triangle.c.position, triangle.a.position );
+            const int level = use_texture ? texture_level( triangle ) : 0;
+            generate_particle_line( triangle, triangle.a.position, triangle.b.position, level, texture_lookups );
+            generate_particle_line( triangle, triangle.b.position, triangle.c.position, level, texture_lookups );
+            generate_particle_line( triangle, triangle.c.position, triangle.a.position, level, texture_lookups );
         }
     }
     else
@@ -483,18 +805,22 @@ void Particles::generate_particle_mesh()
 
             const kl::Float3 a_walk_direction = kl::normalize( triangle.c.position - triangle.a.position );
             const kl::Float3 b_walk_direction = kl::normalize( triangle.c.position - triangle.b.position );
+            const int level = use_texture ? texture_level( triangle ) : 0;
 
             for ( int i = 0; i <= step_count; i++ )
             {
                 const kl::Float3 a_walk_point = triangle.a.position + a_walk_direction * ( i * generation_precision );
                 const kl::Float3 b_walk_point = triangle.b.position + b_walk_direction * ( i * generation_precision );
-                generate_particle_line( triangle, a_walk_point, b_walk_point );
+                generate_particle_line( triangle, a_walk_point, b_walk_point, level, texture_lookups );
             }
         }
     }
+
+    if ( use_texture )
+        generate_particle_texture_colors( texture_lookups );
 }
 
-void Particles::generate_particle_line( kl::Triangle const& triangle, kl::Float3 const& start, kl::Float3 const& end )
+void Particles::generate_particle_line( kl::Triangle const& triangle, kl::Float3 const& start, kl::Float3 const& end, int level, std::vector<TextureLookup>& texture_lookups )
 {
     const float walk_distance = ( end - start ).length();
     const int step_count = int( walk_distance / generation_precision );
@@ -513,12 +839,44 @@ void Particles::generate_particle_line( kl::Triangle const& triangle, kl::Float3
         const float u = kl::Triangle::interpolate( weights, { triangle.a.uv.x, triangle.b.uv.x, triangle.c.uv.x } );
         const float v = kl::Triangle::interpolate( weights, { triangle.a.uv.y, triangle.b.uv.y, triangle.c.uv.y } );
         if ( use_texture )
-            particle.color = selected_texture.sample( { u, 1 - v } );
+            texture_lookups.push_back( { { u, 1 - v }, level } );
         else
             generate_particle_color( particle );
     }
 }
 
+void Particles::generate_particle_texture_colors( std::vector<TextureLookup> const& texture_lookups )
+{
+    std::for_each( std::execution::par, particles.begin(), particles.end(), [&]( Particle& particle )
+        {
+            const TextureLookup& lookup = texture_lookups[&particle - particles.data()];
+            if ( lookup.level < (int) selected_texture_mips.size() )
+                particle.color = selected_texture_mips[lookup.level].sample( lookup.uv );
+            else
+                particle.color = {};
+        } );
+}
+
+int Particles::texture_level( kl::Triangle const& triangle ) const
+{
+    if ( selected_texture_mips.empty() )
+        return 0;
+
+    const kl::Int2 size = selected_texture_mips.front().image.size();
+    const float world_area = kl::cross( triangle.b.position - triangle.a.position, triangle.c.position - triangle.a.position ).length() * 0.5f;
+    if ( world_area <= 0.0f )
+        return 0;
+
+    const kl::Float2 uv_ab = triangle.b.uv - triangle.a.uv;
+    const kl::Float2 uv_ac = triangle.c.uv - triangle.a.uv;
+    const float texel_area = std::abs( uv_ab.x * uv_ac.y - uv_ac.x * uv_ab.y ) * size.x * size.y * 0.5f;
+
+    // Texels covered by the gap between two neighbouring particles
+    const float footprint = std::sqrt( texel_area / world_area ) * generation_precision;
+    const int level = int( std::log2( kl::max( footprint, 1.0f ) ) + 0.5f );
+    return kl::min( level, (int) selected_texture_mips.size() - 1 );
+}
+
 void Particles::generate_particle_color( Particle& particle ) const
 {
     switch ( box_particle_color_type )
@@ -547,6 +905,245 @@ void Particles::generate_particle_color( Particle& particle ) const
     }
 }
 
+kl::Float3 TextureMip::pixel( int x, int y ) const
+{
+    return image.ptr()[x + (size_t) y * image.width()];
+}
+
+kl::Float3 TextureMip::sample( kl::Float2 const& uv ) const
+{
+    // Same as a clamped linear sampler, so border UVs never blend with the opposite edge
+    const int width = image.width();
+    const int height = image.height();
+    const float coord_x = kl::clamp( uv.x * width - 0.5f, 0.0f, width - 1.0f );
+    const float coord_y = kl::clamp( uv.y * height - 0.5f, 0.0f, height - 1.0f );
+    const int x0 = int( coord_x );
+    const int y0 = int( coord_y );
+    const int x1 = kl::min( x0 + 1, width - 1 );
+    const int y1 = kl::min( y0 + 1, height - 1 );
+    const float weight_x = coord_x - x0;
+    const float weight_y = coord_y - y0;
+
+    const kl::Float3 top = pixel( x0, y0 ) * ( 1.0f - weight_x ) + pixel( x1, y0 ) * weight_x;
+    const kl::Float3 bottom = pixel( x0, y1 ) * ( 1.0f - weight_x ) + pixel( x1, y1 ) * weight_x;
+    return top * ( 1.0f - weight_y ) + bottom * weight_y;
+}
+
+kl::Float3 ForceField::texel( int x, int y, int z ) const
+{
+    const DirectX::PackedVector::XMHALF4& value = texels[x + ( y + (size_t) z * resolution ) * resolution];
+    return {
+        DirectX::PackedVector::XMConvertHalfToFloat( value.x ),
+        DirectX::PackedVector::XMConvertHalfToFloat( value.y ),
+        DirectX::PackedVector::XMConvertHalfToFloat( value.z ),
+    };
+}
+
+kl::Float3 ForceField::sample( kl::Float3 const& uvw ) const
+{
+    // Same as a clamped linear sampler, texel centers sit at half offsets
+    int base[3] = {};
+    float weights[3] = {};
+    for ( int i = 0; i < 3; i++ )
+    {
+        const float coord = kl::clamp( uvw[i] * resolution - 0.5f, 0.0f, resolution - 1.0f );
+        base[i] = kl::min( int( coord ), resolution - 2 );
+        weights[i] = coord - base[i];
+    }
+
+    const auto lerp = []( kl::Float3 const& a, kl::Float3 const& b, float t ) { return a + ( b - a ) * t; };
+    const kl::Float3 x00 = lerp( texel( base[0], base[1], base[2] ), texel( base[0] + 1, base[1], base[2] ), weights[0] );
+    const kl::Float3 x10 = lerp( texel( base[0], base[1] + 1, base[2] ), texel( base[0] + 1, base[1] + 1, base[2] ), weights[0] );
+    const kl::Float3 x01 = lerp( texel( base[0], base[1], base[2] + 1 ), texel( base[0] + 1, base[1], base[2] + 1 ), weights[0] );
+    const kl::Float3 x11 = lerp( texel( base[0], base[1] + 1, base[2] + 1 ), texel( base[0] + 1, base[1] + 1, base[2] + 1 ), weights[0] );
+    return lerp( lerp( x00, x10, weights[1] ), lerp( x01, x11, weights[1] ), weights[2] );
+}
+
+static kl::Float3 ray_offset( kl::Float3 const& position, PhysicsCB const& cb )
+{
+    const float distance_t = kl::dot( position - cb.FORCE_RAY_ORIGIN, cb.FORCE_RAY_DIRECTION );
+    const kl::Float3 closest_position = cb.FORCE_RAY_ORIGIN + cb.FORCE_RAY_DIRECTION * distance_t;
+    return position - closest_position;
+}
+
+static kl::Float3 ray_acceleration( kl::Float3 const& position, PhysicsCB const& cb )
+{
+    if ( !cb.USE_RAY_FORCE )
+        return {};
+
+    kl::Float3 acceleration = ray_offset( position, cb );
+    const float force_distance = acceleration.length();
+    acceleration /= force_distance * force_distance;
+    acceleration *= cb.FORCE_STRENGTH;
+    return acceleration;
+}
+
+static kl::Float3 field_acceleration( kl::Float3 const& position, PhysicsCB const& cb, ForceField const& field )
+{
+    if ( !cb.USE_FIELD )
+        return {};
+
+    kl::Float3 uvw;
+    for ( int i = 0; i < 3; i++ )
+        uvw[i] = position[i] / ( 2.0f * cb.CONTAINER_SCALE[i] ) + 0.5f;
+    return field.sample( uvw ) * cb.FIELD_STRENGTH;
+}
+
+static kl::Float3 total_acceleration( kl::Float3 const& position, PhysicsCB const& cb, ForceField const& field )
+{
+    return ray_acceleration( position, cb ) + field_acceleration( position, cb, field );
+}
+
+static void integrate_euler( Particle& particle, PhysicsCB const& cb, ForceField const& field, float delta_time )
+{
+    particle.velocity += total_acceleration( particle.position, cb, field ) * delta_time;
+    particle.position += particle.velocity * delta_time;
+}
+
+static void integrate_verlet( Particle& particle, PhysicsCB const& cb, ForceField const& field, float delta_time )
+{
+    const kl::Float3 old_acceleration = total_acceleration( particle.position, cb, field );
+    particle.position += particle.velocity * delta_time + old_acceleration * ( 0.5f * delta_time * delta_time );
+    const kl::Float3 new_acceleration = total_acceleration( particle.position, cb, field );
+    particle.velocity += ( old_acceleration + new_acceleration ) * ( 0.5f * delta_time );
+}
+
+static UINT substep_count( Particle const& particle, PhysicsCB const& cb )
+{
+    static constexpr float SUBSTEP_ACCURACY = 0.25f;
+
+    if ( !cb.USE_RAY_FORCE )
+        return 1;
+
+    const float force_distance = ray_offset( particle.position, cb ).length();
+    const float time_scale = force_distance / kl::max( particle.velocity.length() + std::sqrt( std::abs( cb.FORCE_STRENGTH ) ), 1e-6f );
+    const float substeps = std::ceil( cb.DELTA_TIME / kl::max( SUBSTEP_ACCURACY * time_scale, 1e-9f ) );
+    return (UINT) kl::clamp( substeps, 1.0f, (float) cb.MAX_SUBSTEPS );
+}
+
+void step_particle( Particle& particle, PhysicsCB const& cb, ForceField const& field )
+{
+    static constexpr float AT_HOME_BIAS = 0.01f;
+
+    if ( cb.RETURN_HOME )
+    {
+        if ( ( particle.position - particle.home ).length() <= AT_HOME_BIAS )
+        {
+            particle.position = particle.home;
+            particle.velocity = {};
+        }
+        else
+            particle.velocity = kl::normalize( particle.home - particle.position ) * cb.RETURN_HOME_VELOCITY;
+    }
+
+    switch ( (IntegrationType) cb.INTEGRATION_TYPE )
+    {
+    default:
+        integrate_euler( particle, cb, field, cb.DELTA_TIME );
+        break;
+
+    case IntegrationType::VELOCITY_VERLET:
+        integrate_verlet( particle, cb, field, cb.DELTA_TIME );
+        break;
+
+    case IntegrationType::ADAPTIVE_VERLET:
+    {
+        const UINT substeps = substep_count( particle, cb );
+        const float substep_time = cb.DELTA_TIME / substeps;
+        for ( UINT i = 0; i < substeps; i++ )
+            integrate_verlet( particle, cb, field, substep_time );
+        break;
+    }
+    }
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        kl::Float3 plane_normal;
+        plane_normal[i] = 1.0f;
+        if ( particle.position[i] < -cb.CONTAINER_SCALE[i] )
+        {
+            particle.position[i] = 1e-3f - cb.CONTAINER_SCALE[i];
+            particle.velocity = kl::reflect( particle.velocity, plane_normal ) * cb.ENERGY_RETAIN;
+        }
+        if ( particle.position[i] > cb.CONTAINER_SCALE[i] )
+        {
+            particle.position[i] = cb.CONTAINER_SCALE[i] - 1e-3f;
+            particle.velocity = kl::reflect( particle.velocity, -plane_normal ) * cb.ENERGY_RETAIN;
+        }
+    }
+}
+
+void benchmark_integrators()
+{
+    static constexpr int PARTICLE_COUNT = 100'000;
+    static constexpr float SIMULATED_TIME = 1.0f;
+    static constexpr float REFERENCE_TIME_STEP = 1.0f / 4000.0f;
+    static constexpr float TIME_STEPS[] = { 1.0f / 240.0f, 1.0f / 120.0f, 1.0f / 60.0f, 1.0f / 30.0f, 1.0f / 15.0f };
+    static constexpr std::pair<IntegrationType, const char*> INTEGRATION_TYPES[] = {
+        { IntegrationType::SEMI_IMPLICIT_EULER, "Semi-Implicit Euler" },
+        { IntegrationType::VELOCITY_VERLET, "Velocity Verlet" },
+        { IntegrationType::ADAPTIVE_VERLET, "Adaptive Verlet" },
+    };
+
+    // Ray goes through the container center, same as holding the mouse over it
+    PhysicsCB cb = {};
+    cb.FORCE_RAY_ORIGIN = { 0.0f, 0.0f, -5.0f };
+    cb.FORCE_RAY_DIRECTION = { 0.0f, 0.0f, 1.0f };
+    cb.USE_RAY_FORCE = 1.0f;
+    cb.FORCE_STRENGTH = 1.0f;
+    cb.CONTAINER_SCALE = kl::Float3{ 1.0f };
+    cb.ENERGY_RETAIN = 0.7f;
+    cb.MAX_SUBSTEPS = SUBSTEP_LIMIT;
+
+    std::vector<Particle> initial_particles( PARTICLE_COUNT );
+    for ( Particle& particle : initial_particles )
+    {
+        particle.home = kl::random::gen_float3( -1.0f, 1.0f );
+        particle.position = particle.home;
+        particle.velocity = kl::random::gen_float3( -0.1f, 0.1f );
+    }
+
+    const ForceField field;
+    const auto simulate = [&]( IntegrationType type, float time_step, std::vector<Particle>& particles )
+        {
+            particles = initial_particles;
+            PhysicsCB step_cb = cb;
+            step_cb.INTEGRATION_TYPE = (UINT) type;
+            step_cb.DELTA_TIME = time_step;
+
+            const auto start_time = std::chrono::steady_clock::now();
+            for ( int i = 0; i < int( SIMULATED_TIME / time_step + 0.5f ); i++ )
+            {
+                std::for_each( std::execution::par_unseq, particles.begin(), particles.end(), [&]( Particle& particle )
+                    {
+                        step_particle( particle, step_cb, field );
+                    } );
+            }
+            return std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+        };
+
+    std::vector<Particle> reference_particles;
+    simulate( IntegrationType::ADAPTIVE_VERLET, REFERENCE_TIME_STEP, reference_particles );
+
+    std::cout << "Integrator, Time Step, Steps, Seconds, RMS Position Error" << std::endl;
+    std::vector<Particle> particles;
+    for ( auto const& [type, name] : INTEGRATION_TYPES )
+    {
+        for ( float time_step : TIME_STEPS )
+        {
+            const double seconds = simulate( type, time_step, particles );
+            double error_sum = 0.0;
+            for ( int i = 0; i < PARTICLE_COUNT; i++ )
+            {
+                const float error = ( particles[i].position - reference_particles[i].position ).length();
+                error_sum += double( error ) * error;
+            }
+            const double rms_error = std::sqrt( error_sum / PARTICLE_COUNT );
+            std::cout << kl::format( name, ", ", time_step, ", ", int( SIMULATED_TIME / time_step + 0.5f ), ", ", seconds, ", ", rms_error ) << std::endl;
+        }
+    }
+}
+
 void drag_int( std::string_view const& text, int& value, std::function<void()> const& callback, float width )
 {
     ImGuiStyle& style = imgui::GetStyle();
@@ -563,7 +1160,7 @@ void drag_int( std::string_view const& text, int& value, std::function<void()> c
     imgui::PopStyleColor( 1 );
 }
 
-void drag_float( std::string_view const& text, float& value, std::function<void()> const& callback, float width )
+void drag_float( std::string_view const& text, float& value, std::function<void()> const& callback, float width, float speed )
 {
     ImGuiStyle& style = imgui::GetStyle();
     imgui::SetCursorPosY( imgui::GetCursorPosY() + style.FramePadding.y );
@@ -573,7 +1170,7 @@ void drag_float( std::string_view const& text, float& value, std::function<void(
     imgui::SetCursorPosY( imgui::GetCursorPosY() - style.FramePadding.y );
     imgui::SetNextItemWidth( width );
     imgui::PushStyleColor( ImGuiCol_Text, F_COLOR );
-    if ( imgui::DragFloat( kl::format( "##", text, "F" ).c_str(), &value, 0.01f ) )
+    if ( imgui::DragFloat( kl::format( "##", text, "F" ).c_str(), &value, speed ) )
         callback();
 
     imgui::PopStyleColor( 1 );
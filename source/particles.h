@@ -1,8 +1,15 @@
 #pragma once
 
 #include "klibrary.h"
+#include <DirectXPackedVector.h>
 
 
+// Keeps every chunk under the 128 MB resource size D3D11 guarantees
+inline constexpr size_t PARTICLE_CHUNK_SIZE = 1 << 21;
+inline constexpr int SUBSTEP_LIMIT = 64;
+inline constexpr int STEPS_PER_FRAME_LIMIT = 8;
+inline constexpr int FIELD_RESOLUTION_LIMIT = 256;
+
 struct Particle
 {
     kl::Float3 home;
@@ -19,6 +26,62 @@ enum struct ColorType
     RANDOM_GRAYSCALE,
 };
 
+struct TextureMip
+{
+    kl::Image image;
+
+    kl::Float3 pixel( int x, int y ) const;
+    kl::Float3 sample( kl::Float2 const& uv ) const;
+};
+
+struct TextureLookup
+{
+    kl::Float2 uv;
+    int level = 0;
+};
+
+enum struct IntegrationType
+{
+    SEMI_IMPLICIT_EULER,
+    VELOCITY_VERLET,
+    ADAPTIVE_VERLET,
+};
+
+enum struct FieldType
+{
+    VORTEX,
+    ATTRACTOR,
+    CURL_NOISE,
+};
+
+struct ForceField
+{
+    int resolution = 0;
+    std::vector<DirectX::PackedVector::XMHALF4> texels;
+
+    kl::Float3 texel( int x, int y, int z ) const;
+    kl::Float3 sample( kl::Float3 const& uvw ) const;
+};
+
+struct alignas( 16 ) PhysicsCB
+{
+    kl::Float3 FORCE_RAY_ORIGIN;
+    float USE_RAY_FORCE;
+    kl::Float3 FORCE_RAY_DIRECTION;
+    float FORCE_STRENGTH;
+    kl::Float3 CONTAINER_SCALE;
+    float RETURN_HOME;
+    float RETURN_HOME_VELOCITY;
+    float ENERGY_RETAIN;
+    float ELAPSED_TIME;
+    float DELTA_TIME;
+    UINT PARTICLE_COUNT;
+    UINT INTEGRATION_TYPE;
+    UINT MAX_SUBSTEPS;
+    float USE_FIELD;
+    float FIELD_STRENGTH;
+};
+
 struct Particles
 {
     // System
@@ -35,7 +98,7 @@ struct Particles
 
     // Selected Texture
     std::string selected_texture_path;
-    kl::Image selected_texture;
+    std::vector<TextureMip> selected_texture_mips;
 
     // Container
     kl::dx::Buffer container_mesh;
@@ -43,8 +106,8 @@ struct Particles
 
     // Particles
     std::vector<Particle> particles;
-    kl::dx::Buffer particle_buffer;
-    kl::dx::AccessView particle_buffer_view;
+    std::vector<kl::dx::Buffer> particle_buffers;
+    std::vector<kl::dx::AccessView> particle_buffer_views;
 
     // Shaders
     kl::Shaders shaders;
@@ -60,6 +123,24 @@ struct Particles
     float energy_retain = 0.7f;
     bool return_home = false;
     float return_home_velocity = 0.5f;
+    bool use_cpu_physics = false;
+    IntegrationType integration_type = IntegrationType::SEMI_IMPLICIT_EULER;
+    int max_substeps = 16;
+    float simulation_speed = 1.0f;
+    bool use_fixed_time_step = false;
+    float fixed_time_step = 1.0f / 60.0f;
+    float time_step_accumulator = 0.0f;
+
+    // Force Field
+    bool use_field = false;
+    float field_strength = 1.0f;
+    FieldType field_type = FieldType::VORTEX;
+    int field_resolution = 64;
+    float field_frequency = 4.0f;
+    std::string field_path;
+    ForceField field;
+    kl::dx::ShaderView field_view;
+    kl::dx::SamplerState field_sampler;
 
     // Particle Box
     int box_particle_count = 1'000'000;
@@ -87,21 +168,38 @@ private:
     void handle_keybinds();
     void update_camera();
     void compute_physics();
+    void compute_physics_gpu( PhysicsCB const& cb );
+    void compute_physics_cpu( PhysicsCB const& cb );
+    void upload_particle_buffers();
     void render_particles();
     void render_ui();
 
     void reload_selected_mesh();
     void reload_selected_texture();
-    void reload_particle_buffer();
+    void reload_particle_buffers();
+    bool read_particle_buffers();
+    size_t gpu_particle_count();
     void reload_container_mesh();
+    void reload_field_view();
+
+    void bake_field();
+    bool load_field();
+    bool save_field( std::string const& path ) const;
 
     void generate_particle_box();
     void generate_particle_mesh();
 
-    void generate_particle_line( kl::Triangle const& triangle, kl::Float3 const& start, kl::Float3 const& end );
+    void generate_particle_line( kl::Triangle const& triangle, kl::Float3 const& start, kl::Float3 const& end, int level, std::vector<TextureLookup>& texture_lookups );
+    void generate_particle_texture_colors( std::vector<TextureLookup> const& texture_lookups );
+
+    int texture_level( kl::Triangle const& triangle ) const;
     void generate_particle_color( Particle& particle ) const;
 };
 
+void step_particle( Particle& particle, PhysicsCB const& cb, ForceField const& field );
+
+void benchmark_integrators();
+
 void drag_int( std::string_view const& text, int& value, std::function<void()> const& callback, float width = 100.0f );
-void drag_float( std::string_view const& text, float& value, std::function<void()> const& callback, float width = 100.0f );
+void drag_float( std::string_view const& text, float& value, std::function<void()> const& callback, float width = 100.0f, float speed = 0.01f );
 void drag_float3( std::string_view const& text, kl::Float3& value, std::function<void()> const& callback, float width = 100.0f );
@@ -7,6 +7,11 @@ struct Particle
 };
 
 static const float AT_HOME_BIAS = 0.01f;
+static const float SUBSTEP_ACCURACY = 0.25f;
+
+static const uint SEMI_IMPLICIT_EULER = 0;
+static const uint VELOCITY_VERLET = 1;
+static const uint ADAPTIVE_VERLET = 2;
 
 float3 FORCE_RAY_ORIGIN;
 float USE_RAY_FORCE;
@@ -19,9 +24,75 @@ float ENERGY_RETAIN;
 float ELAPSED_TIME;
 float DELTA_TIME;
 uint PARTICLE_COUNT;
+uint INTEGRATION_TYPE;
+uint MAX_SUBSTEPS;
+float USE_FIELD;
+float FIELD_STRENGTH;
+
+Texture3D<float4> FIELD : register(t0);
+SamplerState FIELD_SAMPLER : register(s0);
 
 RWStructuredBuffer<Particle> PARTICLES : register(u0);
 
+float3 ray_offset(float3 position)
+{
+    const float distance_t = dot(position - FORCE_RAY_ORIGIN, FORCE_RAY_DIRECTION);
+    const float3 closest_position = FORCE_RAY_ORIGIN + FORCE_RAY_DIRECTION * distance_t;
+    return position - closest_position;
+}
+
+float3 ray_acceleration(float3 position)
+{
+    if (!USE_RAY_FORCE)
+        return 0.0f;
+    
+    float3 acceleration = ray_offset(position);
+    const float force_distance = length(acceleration);
+    acceleration /= force_distance * force_distance;
+    acceleration *= FORCE_STRENGTH;
+    return acceleration;
+}
+
+float3 field_acceleration(float3 position)
+{
+    if (!USE_FIELD)
+        return 0.0f;
+    
+    const float3 uvw = position / (2.0f * CONTAINER_SCALE) + 0.5f;
+    return FIELD.SampleLevel(FIELD_SAMPLER, uvw, 0).xyz * FIELD_STRENGTH;
+}
+
+float3 total_acceleration(float3 position)
+{
+    return ray_acceleration(position) + field_acceleration(position);
+}
+
+void integrate_euler(inout Particle particle, float delta_time)
+{
+    particle.velocity += total_acceleration(particle.position) * delta_time;
+    particle.position += particle.velocity * delta_time;
+}
+
+void integrate_verlet(inout Particle particle, float delta_time)
+{
+    const float3 old_acceleration = total_acceleration(particle.position);
+    particle.position += particle.velocity * delta_time + old_acceleration * (0.5f * delta_time * delta_time);
+    const float3 new_acceleration = total_acceleration(particle.position);
+    particle.velocity += (old_acceleration + new_acceleration) * (0.5f * delta_time);
+}
+
+// Ray force grows as 1/d, so the local time scale shrinks with the distance to the ray
+uint substep_count(Particle particle)
+{
+    if (!USE_RAY_FORCE)
+        return 1;
+    
+    const float force_distance = length(ray_offset(particle.position));
+    const float time_scale = force_distance / max(length(particle.velocity) + sqrt(abs(FORCE_STRENGTH)), 1e-6f);
+    const float substeps = ceil(DELTA_TIME / max(SUBSTEP_ACCURACY * time_scale, 1e-9f));
+    return (uint) clamp(substeps, 1.0f, (float) max(MAX_SUBSTEPS, 1));
+}
+
 [numthreads(1024, 1, 1)]
 void c_shader(uint3 thread_id : SV_DispatchThreadID)
 {
@@ -41,18 +112,21 @@ void c_shader(uint3 thread_id : SV_DispatchThreadID)
             particle.velocity = normalize(particle.home - particle.position) * RETURN_HOME_VELOCITY;
     }
     
-    if (USE_RAY_FORCE)
+    if (INTEGRATION_TYPE == VELOCITY_VERLET)
     {
-        const float distance_t = dot(particle.position - FORCE_RAY_ORIGIN, FORCE_RAY_DIRECTION);
-        const float3 closest_position = FORCE_RAY_ORIGIN + FORCE_RAY_DIRECTION * distance_t;
-        float3 acceleration = particle.position - closest_position;
-        const float force_distance = length(acceleration);
-        acceleration /= force_distance * force_distance;
-        acceleration *= FORCE_STRENGTH;
-        particle.velocity += acceleration * DELTA_TIME;
+        integrate_verlet(particle, DELTA_TIME);
+    }
+    else if (INTEGRATION_TYPE == ADAPTIVE_VERLET)
+    {
+        const uint substeps = substep_count(particle);
+        const float substep_time = DELTA_TIME / substeps;
+        for (uint i = 0; i < substeps; i++)
+            integrate_verlet(particle, substep_time);
+    }
+    else
+    {
+        integrate_euler(particle, DELTA_TIME);
     }
-    
-    particle.position += particle.velocity * DELTA_TIME;
     
     for (int i = 0; i < 3; i++)
     {